@@ -0,0 +1,150 @@
+#ifndef COMMANDS_H
+#define COMMANDS_H
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "MoveHelper.h"
+#include "Motion.h"
+
+bool starts_with(const char *restrict string, const char *restrict prefix)
+{
+    while (*prefix)
+    {
+        if (*prefix++ != *string++)
+            return 0;
+    }
+
+    return 1;
+}
+
+/**
+  * @brief Executes a received command and writes the answer into the same buffer
+  * @param[in,out] rx_buffer: Null-terminated command, overwritten with the answer (at least 128 bytes)
+  */
+void handleCommand(char *rx_buffer)
+{
+    if (!strcmp(rx_buffer, "?Mode"))
+    {
+        sprintf(rx_buffer, "Current Mode = %s", automatic ? "Automatic" : "Manual");
+    }
+    else if (starts_with(rx_buffer, "Mode="))
+    {
+        if (!strcmp(rx_buffer + 5, "Automatic"))
+        {
+            automatic = 1;
+            sprintf(rx_buffer, "Setting Mode to Automatic");
+        }
+        else if (!strcmp(rx_buffer + 5, "Manual"))
+        {
+            automatic = 0;
+            sprintf(rx_buffer, "Setting Mode to Manual");
+        }
+        else
+        {
+            sprintf(rx_buffer, "Could not recognize the mode");
+        }
+    }
+    else if (!strcmp(rx_buffer, "?AutomaticMoveDistance"))
+    {
+        sprintf(rx_buffer, "Current Automatic Move Distance = %f mm", automaticMoveDistanceMM);
+    }
+    else if (starts_with(rx_buffer, "AutomaticMoveDistance="))
+    {
+        automaticMoveDistanceMM = atof(rx_buffer + 22);
+        sprintf(rx_buffer, "Setting Automatic Move Distance to %f mm", automaticMoveDistanceMM);
+    }
+    else if (!strcmp(rx_buffer, "?AutomaticMoveInterval"))
+    {
+        sprintf(rx_buffer, "Current Automatic Move Interval = %f s", automaticMoveIntervalSec);
+    }
+    else if (starts_with(rx_buffer, "AutomaticMoveInterval="))
+    {
+        automaticMoveIntervalSec = atof(rx_buffer + 22);
+        sprintf(rx_buffer, "Setting Automatic Move Interval to %f s", automaticMoveIntervalSec);
+    }
+    else if (!strcmp(rx_buffer, "?Pos"))
+    {
+        sprintf(rx_buffer, "Current Position = %f mm (%lld steps)", steps2mm(currentPosition), (long long)currentPosition);
+    }
+    else if (starts_with(rx_buffer, "Pos="))
+    {
+        double targetPositionMM = atof(rx_buffer + 4);
+        if (targetPositionMM < 0)
+        {
+            sprintf(rx_buffer, "Negative Positions not allowed");
+        }
+        else
+        {
+            uint64_t newTargetPosition = mm2steps(targetPositionMM);
+            // Set direction
+            setDirection(newTargetPosition > currentPosition);
+
+            if (direction == FORWARD && endButtonLevel())
+            {
+                sprintf(rx_buffer, "Can't move forward, because end button is pressed");
+            }
+            else if (direction == BACKWARD && startButtonLevel())
+            {
+                sprintf(rx_buffer, "Can't move backward, because start button is pressed");
+            }
+            else
+            {
+                sprintf(rx_buffer, "Target Position  = %f mm (%lld steps)", targetPositionMM, (long long)newTargetPosition);
+                targetPosition = newTargetPosition;
+
+                if (targetPosition != currentPosition)
+                {
+                    moveTimerStart();
+                }
+            }
+        }
+    }
+    else if (starts_with(rx_buffer, "Resume") || starts_with(rx_buffer, "Start"))
+    {
+        moveTimerStart();
+    }
+    else if (starts_with(rx_buffer, "Pause") || starts_with(rx_buffer, "Stop"))
+    {
+        moveTimerPause();
+    }
+    else if (starts_with(rx_buffer, "Home"))
+    {
+        if (goHome())
+        {
+            sprintf(rx_buffer, "Going Home");
+
+            moveTimerStart();
+        }
+        else
+        {
+            sprintf(rx_buffer, "Already Home");
+        }
+    }
+    else if (!strcmp(rx_buffer, "?Home"))
+    {
+        sprintf(rx_buffer, "%s: %d", startButtonLevel() ? "Is Home" : "Not Home", btn_start_pressed);
+    }
+    else if (!strcmp(rx_buffer, "?End"))
+    {
+        sprintf(rx_buffer, "%s: %d", endButtonLevel() ? "Is End" : "Not End", btn_end_pressed);
+    }
+    else if (!strcmp(rx_buffer, "?Feedrate"))
+    {
+        sprintf(rx_buffer, "Current Feedrate = %f mm/min (delay = %f s)", feedrate, feedrate2delay(feedrate));
+    }
+    else if (starts_with(rx_buffer, "Feedrate="))
+    {
+        feedrate = atof(rx_buffer + 9);
+        moveTimerSetInterval(feedrate2delay(feedrate));
+        sprintf(rx_buffer, "New Feedrate = %f mm/min (delay = %f s)", feedrate, feedrate2delay(feedrate));
+    }
+    else
+    {
+        sprintf(rx_buffer, "Unrecognized Command");
+    }
+}
+
+#endif /* COMMANDS_H */
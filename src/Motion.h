@@ -0,0 +1,165 @@
+#ifndef MOTION_H
+#define MOTION_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef ESP_PLATFORM
+#include "esp_attr.h"
+#else
+#define IRAM_ATTR
+#endif
+
+#include "MoveHelper.h"
+
+#define SAFETY_DIST 100 ///< [steps] Steps to move away from a limit switch until it is released again
+
+double feedrate = 550.0; ///< [mm / min] Feedrate
+
+uint64_t targetPosition = 0;
+int64_t currentPosition = 0;
+DIRECTION direction = FORWARD;
+bool automatic = true;
+double automaticMoveDistanceMM = 100;
+double automaticMoveIntervalSec = 30 * 60;
+
+int btn_start_pressed = 0;
+int btn_end_pressed = 0;
+
+typedef enum
+{
+    TICK_BLOCKED = 0,       ///< A pressed limit switch blocks the move, the step pin is untouched
+    TICK_STEPPED = 1,       ///< The step pin was toggled
+    TICK_TARGET_REACHED = 2 ///< The step pin was toggled and the target position is reached
+} TICK_RESULT;
+
+/*
+ * Hardware access of the motion logic.
+ * Implemented by the firmware (main.c) and by the host side replay harness (test/)
+ */
+void setDirection(DIRECTION dir);
+int startButtonLevel(void);
+int endButtonLevel(void);
+void moveTimerStart(void);
+void moveTimerPause(void);
+void moveTimerSetInterval(double timer_interval_sec);
+
+/**
+  * @brief Motion logic of the move timer interrupt. Called on every alarm (two alarms per step)
+  * @param[in,out] stepLevel: Level of the step pin, gets toggled if the motor is allowed to move
+  * @retval TICK_RESULT What the interrupt has to do with the step pin and the timer
+  */
+static inline TICK_RESULT IRAM_ATTR moveTimerTick(int *stepLevel)
+{
+    if (btn_start_pressed && direction == BACKWARD)
+    {
+        currentPosition = 0;
+        targetPosition = 0;
+        return TICK_BLOCKED;
+    }
+    if (btn_end_pressed && direction == FORWARD)
+    {
+        return TICK_BLOCKED;
+    }
+
+    *stepLevel = !*stepLevel;
+
+    if (*stepLevel)
+    {
+        if (direction == FORWARD)
+        {
+            if (btn_start_pressed)
+            {
+                btn_start_pressed--;
+            }
+            currentPosition++;
+        }
+        else
+        {
+            if (btn_end_pressed)
+            {
+                btn_end_pressed--;
+            }
+            currentPosition--;
+        }
+    }
+
+    return targetPosition == currentPosition ? TICK_TARGET_REACHED : TICK_STEPPED;
+}
+
+/**
+  * @brief Handles a rising edge of the start button
+  */
+void startButtonHit(void)
+{
+    btn_start_pressed = SAFETY_DIST;
+    btn_end_pressed = 0;
+
+    currentPosition = 0;
+    if (direction == BACKWARD)
+    {
+        targetPosition = 0;
+    }
+}
+
+/**
+  * @brief Handles a rising edge of the end button
+  */
+void endButtonHit(void)
+{
+    btn_end_pressed = SAFETY_DIST;
+    btn_start_pressed = 0;
+}
+
+/**
+  * @brief Prepares a move back to the start button. The timer is not started.
+  * @retval bool False if the start button is already pressed
+  */
+bool goHome(void)
+{
+    if (!btn_start_pressed && !startButtonLevel())
+    {
+        setDirection(BACKWARD);
+
+        targetPosition = 0;
+        currentPosition = mm2steps(700);
+        return true;
+    }
+    return false;
+}
+
+/**
+  * @brief Starts the next automatic move in the current direction
+  * @retval bool False if the limit switch in the current direction is pressed
+  */
+bool automaticMoveStart(void)
+{
+    if (direction == FORWARD)
+    {
+        if (!btn_end_pressed && !endButtonLevel())
+        {
+            targetPosition = currentPosition + mm2steps(automaticMoveDistanceMM);
+            moveTimerStart();
+            return true;
+        }
+    }
+    else if (direction == BACKWARD)
+    {
+        if (!btn_start_pressed && !startButtonLevel())
+        {
+            if (currentPosition - mm2steps(automaticMoveDistanceMM) < 0)
+            {
+                targetPosition = 0;
+            }
+            else
+            {
+                targetPosition = currentPosition - mm2steps(automaticMoveDistanceMM);
+            }
+            moveTimerStart();
+            return true;
+        }
+    }
+    return false;
+}
+
+#endif /* MOTION_H */
@@ -6,6 +6,8 @@
 #include "freertos/task.h"
 #include "freertos/queue.h"
 
+#include "Motion.h"
+
 #define LED_GPIO GPIO_NUM_2
 
 #define ESP_INTR_FLAG_DEFAULT 0
@@ -18,10 +20,6 @@
 #define GPIO_BTN_END GPIO_NUM_17
 #define GPIO_INPUT_PIN_SEL ((1ULL << GPIO_BTN_START) | (1ULL << GPIO_BTN_END))
 
-#define SAFETY_DIST 100
-int btn_start_pressed = 0;
-int btn_end_pressed = 0;
-
 static xQueueHandle gpio_evt_queue = NULL;
 
 static void IRAM_ATTR gpio_isr_handler(void *arg)
@@ -43,19 +41,11 @@ static void gpio_task(void *arg)
             {
                 if (io_num == GPIO_BTN_START)
                 {
-                    btn_start_pressed = SAFETY_DIST;
-                    btn_end_pressed = 0;
-
-                    currentPosition = 0;
-                    if (direction == BACKWARD)
-                    {
-                        targetPosition = 0;
-                    }
+                    startButtonHit();
                 }
                 else if (io_num == GPIO_BTN_END)
                 {
-                    btn_end_pressed = SAFETY_DIST;
-                    btn_start_pressed = 0;
+                    endButtonHit();
                 }
             }
         }
@@ -25,36 +25,42 @@
 #include "MoveHelper.h"
 #include "wifi.h"
 #include "TimerManager.h"
+#include "Motion.h"
+#include "gpio.h"
+#include "Commands.h"
 
-double feedrate = 550.0; ///< [mm / min] Feedrate
+static const char *TAG = "CameraMover";
 
-uint64_t targetPosition = 0;
-int64_t currentPosition = 0;
-DIRECTION direction = FORWARD;
-bool automatic = true;
-double automaticMoveDistanceMM = 100;
-double automaticMoveIntervalSec = 30 * 60;
+void setDirection(DIRECTION dir)
+{
+    direction = dir;
+    gpio_set_level(GPIO_DIR, !direction);
+    ESP_LOGI(TAG, "Setting Direction = %s", (direction == FORWARD ? "Forward" : "Backward"));
+}
 
-#include "gpio.h"
+int startButtonLevel(void)
+{
+    return gpio_get_level(GPIO_BTN_START);
+}
 
-static const char *TAG = "CameraMover";
+int endButtonLevel(void)
+{
+    return gpio_get_level(GPIO_BTN_END);
+}
 
-bool starts_with(const char *restrict string, const char *restrict prefix)
+void moveTimerStart(void)
 {
-    while (*prefix)
-    {
-        if (*prefix++ != *string++)
-            return 0;
-    }
+    timer_start(TIMER_GROUP_0, TIMER_0);
+}
 
-    return 1;
+void moveTimerPause(void)
+{
+    timer_pause(TIMER_GROUP_0, TIMER_0);
 }
 
-void setDirection(DIRECTION dir)
+void moveTimerSetInterval(double timer_interval_sec)
 {
-    direction = dir;
-    gpio_set_level(GPIO_DIR, !direction);
-    ESP_LOGI(TAG, "Setting Direction = %s", (direction == FORWARD ? "Forward" : "Backward"));
+    tg0_timer_set_interval(timer_interval_sec);
 }
 
 static void udp_server_task(void *pvParameters)
@@ -131,130 +137,7 @@ static void udp_server_task(void *pvParameters)
                 ESP_LOGI(TAG, "Received %d bytes from %s:", len, addr_str);
                 ESP_LOGI(TAG, "%s", rx_buffer);
 
-                if (!strcmp(rx_buffer, "?Mode"))
-                {
-                    sprintf(rx_buffer, "Current Mode = %s", automatic ? "Automatic" : "Manual");
-                }
-                else if (starts_with(rx_buffer, "Mode="))
-                {
-                    if (!strcmp(rx_buffer + 5, "Automatic"))
-                    {
-                        automatic = 1;
-                        sprintf(rx_buffer, "Setting Mode to Automatic");
-                    }
-                    else if (!strcmp(rx_buffer + 5, "Manual"))
-                    {
-                        automatic = 0;
-                        sprintf(rx_buffer, "Setting Mode to Manual");
-                    }
-                    else
-                    {
-                        sprintf(rx_buffer, "Could not recognize the mode");
-                    }
-                }
-                else if (!strcmp(rx_buffer, "?AutomaticMoveDistance"))
-                {
-                    sprintf(rx_buffer, "Current Automatic Move Distance = %f mm", automaticMoveDistanceMM);
-                }
-                else if (starts_with(rx_buffer, "AutomaticMoveDistance="))
-                {
-                    automaticMoveDistanceMM = atof(rx_buffer + 22);
-                    sprintf(rx_buffer, "Setting Automatic Move Distance to %f mm", automaticMoveDistanceMM);
-                }
-                else if (!strcmp(rx_buffer, "?AutomaticMoveInterval"))
-                {
-                    sprintf(rx_buffer, "Current Automatic Move Interval = %f s", automaticMoveIntervalSec);
-                }
-                else if (starts_with(rx_buffer, "AutomaticMoveInterval="))
-                {
-                    automaticMoveIntervalSec = atof(rx_buffer + 22);
-                    sprintf(rx_buffer, "Setting Automatic Move Interval to %f s", automaticMoveIntervalSec);
-                }
-                else if (!strcmp(rx_buffer, "?Pos"))
-                {
-                    sprintf(rx_buffer, "Current Position = %f mm (%lld steps)", steps2mm(currentPosition), currentPosition);
-                }
-                else if (starts_with(rx_buffer, "Pos="))
-                {
-                    double targetPositionMM = atof(rx_buffer + 4);
-                    if (targetPositionMM < 0)
-                    {
-                        sprintf(rx_buffer, "Negative Positions not allowed");
-                    }
-                    else
-                    {
-                        uint64_t newTargetPosition = mm2steps(targetPositionMM);
-                        // Set direction
-                        setDirection(newTargetPosition > currentPosition);
-
-                        if (direction == FORWARD && gpio_get_level(GPIO_BTN_END))
-                        {
-                            sprintf(rx_buffer, "Can't move forward, because end button is pressed");
-                        }
-                        else if (direction == BACKWARD && gpio_get_level(GPIO_BTN_START))
-                        {
-                            sprintf(rx_buffer, "Can't move backward, because start button is pressed");
-                        }
-                        else
-                        {
-                            sprintf(rx_buffer, "Target Position  = %f mm (%lld steps)", targetPositionMM, newTargetPosition);
-                            targetPosition = newTargetPosition;
-
-                            if (targetPosition != currentPosition)
-                            {
-                                timer_start(TIMER_GROUP_0, TIMER_0);
-                            }
-                        }
-                    }
-                }
-                else if (starts_with(rx_buffer, "Resume") || starts_with(rx_buffer, "Start"))
-                {
-                    timer_start(TIMER_GROUP_0, TIMER_0);
-                }
-                else if (starts_with(rx_buffer, "Pause") || starts_with(rx_buffer, "Stop"))
-                {
-                    timer_pause(TIMER_GROUP_0, TIMER_0);
-                }
-                else if (starts_with(rx_buffer, "Home"))
-                {
-                    if (!btn_start_pressed && !gpio_get_level(GPIO_BTN_START))
-                    {
-                        setDirection(BACKWARD);
-
-                        targetPosition = 0;
-                        currentPosition = mm2steps(700);
-
-                        sprintf(rx_buffer, "Going Home");
-
-                        timer_start(TIMER_GROUP_0, TIMER_0);
-                    }
-                    else
-                    {
-                        sprintf(rx_buffer, "Already Home");
-                    }
-                }
-                else if (!strcmp(rx_buffer, "?Home"))
-                {
-                    sprintf(rx_buffer, "%s: %d", gpio_get_level(GPIO_BTN_START) ? "Is Home" : "Not Home", btn_start_pressed);
-                }
-                else if (!strcmp(rx_buffer, "?End"))
-                {
-                    sprintf(rx_buffer, "%s: %d", gpio_get_level(GPIO_BTN_END) ? "Is End" : "Not End", btn_end_pressed);
-                }
-                else if (!strcmp(rx_buffer, "?Feedrate"))
-                {
-                    sprintf(rx_buffer, "Current Feedrate = %f mm/min (delay = %f s)", feedrate, feedrate2delay(feedrate));
-                }
-                else if (starts_with(rx_buffer, "Feedrate="))
-                {
-                    feedrate = atof(rx_buffer + 9);
-                    tg0_timer_set_interval(feedrate2delay(feedrate));
-                    sprintf(rx_buffer, "New Feedrate = %f mm/min (delay = %f s)", feedrate, feedrate2delay(feedrate));
-                }
-                else
-                {
-                    sprintf(rx_buffer, "Unrecognized Command");
-                }
+                handleCommand(rx_buffer);
 
                 int err = sendto(sock, rx_buffer, strlen(rx_buffer), 0, (struct sockaddr *)&source_addr, sizeof(source_addr));
                 if (err < 0)
@@ -283,42 +166,16 @@ void IRAM_ATTR timer_group0_isr(void *param)
       we need enable it again, so it is triggered the next time */
     TIMERG0.hw_timer[0].config.alarm_en = TIMER_ALARM_EN;
 
-    if (btn_start_pressed && direction == BACKWARD)
-    {
-        currentPosition = 0;
-        targetPosition = 0;
-        return;
-    }
-    if (btn_end_pressed && direction == FORWARD)
+    TICK_RESULT result = moveTimerTick((int *)param);
+    if (result == TICK_BLOCKED)
     {
         return;
     }
 
     // Toggle Step Pin
-    gpio_set_level(GPIO_STEP, !*(int *)param);
-    *(int *)param = !*(int *)param;
+    gpio_set_level(GPIO_STEP, *(int *)param);
 
-    if (*(int *)param)
-    {
-        if (direction == FORWARD)
-        {
-            if (btn_start_pressed)
-            {
-                btn_start_pressed--;
-            }
-            currentPosition++;
-        }
-        else
-        {
-            if (btn_end_pressed)
-            {
-                btn_end_pressed--;
-            }
-            currentPosition--;
-        }
-    }
-
-    if (targetPosition == currentPosition)
+    if (result == TICK_TARGET_REACHED)
     {
         timer_pause(TIMER_GROUP_0, TIMER_0);
     }
@@ -347,44 +204,16 @@ void app_main()
     tg0_timer_init(feedrate2delay(feedrate));
 
     // Go Home
-    if (!btn_start_pressed && !gpio_get_level(GPIO_BTN_START))
-    {
-        setDirection(BACKWARD);
-
-        targetPosition = 0;
-        currentPosition = mm2steps(700);
-    }
+    goHome();
 
     while (1)
     {
         while (automatic)
         {
-            if (direction == FORWARD)
-            {
-                if (!btn_end_pressed && !gpio_get_level(GPIO_BTN_END))
-                {
-                    targetPosition = currentPosition + mm2steps(automaticMoveDistanceMM);
-                    timer_start(TIMER_GROUP_0, TIMER_0);
-                    vTaskDelay(automaticMoveIntervalSec * 1000 / portTICK_PERIOD_MS);
-                    break;
-                }
-            }
-            else if (direction == BACKWARD)
+            if (automaticMoveStart())
             {
-                if (!btn_start_pressed && !gpio_get_level(GPIO_BTN_START))
-                {
-                    if (currentPosition - mm2steps(automaticMoveDistanceMM) < 0)
-                    {
-                        targetPosition = 0;
-                    }
-                    else
-                    {
-                        targetPosition = currentPosition - mm2steps(automaticMoveDistanceMM);
-                    }
-                    timer_start(TIMER_GROUP_0, TIMER_0);
-                    vTaskDelay(automaticMoveIntervalSec * 1000 / portTICK_PERIOD_MS);
-                    break;
-                }
+                vTaskDelay(automaticMoveIntervalSec * 1000 / portTICK_PERIOD_MS);
+                break;
             }
 
             setDirection(!direction);
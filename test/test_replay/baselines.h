@@ -0,0 +1,35 @@
+#ifndef BASELINES_H
+#define BASELINES_H
+
+#define REGRESSION_SLACK 0.001 ///< Allowed regression of the times and step errors (last digit of the stored %.3f values)
+
+/*
+ * Stored measurements of a trace, the fields are described in ReplayResult (replay.h).
+ * The finished moves have to match exactly, all other values must not get worse.
+ */
+typedef struct
+{
+    const char *name; ///< Name of the trace in traces.h
+    double stepErrorMaxUs;
+    double stepErrorMeanUs;
+    unsigned long long isrCalls;
+    unsigned long long isrBlockedCalls;
+    double latencyP50Sec;
+    double latencyP95Sec;
+    double latencyMaxSec;
+    int movesFinished;
+    int movesUnfinished;
+} Baseline;
+
+/*
+ * Measurements of the traces in traces.h. After an intended change of the motion logic,
+ * replace the entries with the lines printed by the test run.
+ */
+static const Baseline baselines[] = {
+    {"manual_moves", 0.218, 0.121, 3749, 0, 3.000, 3.182, 3.182, 3, 1},
+    {"homing", 0.036, 0.036, 7582, 2291, 0.544, 0.544, 0.544, 1, 2},
+    {"end_switch", 0.036, 0.036, 22956, 917, 18.585, 18.585, 18.585, 1, 1},
+    {"automatic", 0.036, 0.036, 8206, 1375, 2.180, 2.182, 2.182, 6, 1},
+};
+
+#endif /* BASELINES_H */
@@ -0,0 +1,465 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <math.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "MoveHelper.h"
+#include "Motion.h"
+#include "Commands.h"
+
+#define REPLAY_TIMER_SCALE (80000000ULL / 16) ///< [ticks / s] Same as TIMER_SCALE in TimerManager.h (APB clock / TIMER_DIVIDER)
+#define REPLAY_ISR_COST_US 2.0                ///< [µs] Assumed cost of one timer interrupt on the ESP32 (entry, body and exit)
+#define REPLAY_MAX_MOVES 64                   ///< Maximum amount of finished moves per trace (latency samples), more fail the trace
+#define REPLAY_MAX_AUTOMATIC_TRIES 2          ///< The automatic loop tries both directions, then waits for an event or a limit switch counter change
+
+#define REPLAY_NEVER UINT64_MAX
+
+typedef struct
+{
+    double stepErrorMaxUs;    ///< [µs] Largest deviation of a step period from the period the feedrate demands
+    double stepErrorMeanUs;   ///< [µs] Mean deviation of the step periods
+    uint64_t steps;           ///< Steps done by the motor
+    uint64_t isrCalls;        ///< Timer interrupts in total
+    uint64_t isrBlockedCalls; ///< Timer interrupts which were blocked by a limit switch and did not move the motor
+    double isrLoadPercent;    ///< [%] isrCalls * REPLAY_ISR_COST_US over the trace duration. Not measured, only reported (no baseline)
+    double latencyP50Sec;     ///< [s] Median time from a command (or automatic move) until its target is reached
+    double latencyP95Sec;     ///< [s] 95th percentile of the move latencies
+    double latencyMaxSec;     ///< [s] Slowest move
+    int movesFinished;        ///< Moves which reached their target
+    int movesUnfinished;      ///< Moves which were started but never reached their target (superseded or blocked)
+    int64_t finalPosition;    ///< [steps] Position at the end of the trace
+    int64_t expectedPosition; ///< [steps] Position the trace expects at its end
+    int failedExpectations;   ///< Answers which did not match the 'expect' lines of the trace and invalid lines
+    char error[160];          ///< First failed expectation or parse error
+} ReplayResult;
+
+/*
+ * Virtual hardware the firmware logic runs against.
+ * Time is counted in ticks of the move timer, so the replay is deterministic and independent of the host.
+ */
+static struct
+{
+    uint64_t now;           ///< [ticks] Virtual time
+    bool timerRunning;      ///< Move timer is counting
+    uint64_t alarmTicks;    ///< [ticks] Alarm value of the move timer (auto reload)
+    uint64_t reloadTick;    ///< [ticks] Virtual time the timer counter was zero (while running)
+    uint64_t pausedCounter; ///< [ticks] Counter value of the paused timer
+    int stepLevel;          ///< Level of the step pin (the ISR parameter on the ESP32)
+    int startLevel;         ///< Level of the start button pin
+    int endLevel;           ///< Level of the end button pin
+    uint64_t nextAutoTick;  ///< [ticks] Virtual time the automatic loop wakes up from vTaskDelay
+
+    uint64_t lastStepTick; ///< [ticks] Time of the previous step
+    bool lastStepValid;    ///< Previous step belongs to the same uninterrupted move at the same feedrate
+    double stepErrorSumUs;
+    uint64_t stepErrorCount;
+
+    bool movePending;      ///< A move was started and its target is not reached yet
+    uint64_t moveStartTick;
+    int moveCount;
+    double moveLatencies[REPLAY_MAX_MOVES];
+
+    ReplayResult *result;
+} replay;
+
+static void replay_fail(const char *format, ...);
+
+void setDirection(DIRECTION dir)
+{
+    direction = dir;
+}
+
+int startButtonLevel(void)
+{
+    return replay.startLevel;
+}
+
+int endButtonLevel(void)
+{
+    return replay.endLevel;
+}
+
+void moveTimerStart(void)
+{
+    if (!replay.timerRunning)
+    {
+        replay.timerRunning = true;
+        replay.reloadTick = replay.now - replay.pausedCounter;
+    }
+}
+
+void moveTimerPause(void)
+{
+    if (replay.timerRunning)
+    {
+        replay.timerRunning = false;
+        replay.pausedCounter = replay.now - replay.reloadTick;
+        replay.lastStepValid = false;
+    }
+}
+
+void moveTimerSetInterval(double timer_interval_sec)
+{
+    double ticks = timer_interval_sec * REPLAY_TIMER_SCALE;
+    replay.lastStepValid = false;
+    if (!(ticks >= 1.0 && ticks < (double)INT64_MAX))
+    {
+        // Virtual time would not advance (or wrap), the timer stays stopped
+        replay_fail("Invalid timer interval %g s (feedrate %g mm/min)", timer_interval_sec, feedrate);
+        moveTimerPause();
+        replay.alarmTicks = 0;
+        return;
+    }
+    replay.alarmTicks = (uint64_t)ticks;
+}
+
+/*
+ * Time of the next alarm. A counter which is already past a new (lower) alarm value triggers immediately.
+ */
+static uint64_t replay_next_alarm(void)
+{
+    if (!replay.timerRunning || !replay.alarmTicks)
+    {
+        return REPLAY_NEVER;
+    }
+    uint64_t alarm = replay.reloadTick + replay.alarmTicks;
+    return alarm < replay.now ? replay.now : alarm;
+}
+
+static void replay_move_started(void)
+{
+    if (replay.movePending)
+    {
+        replay.result->movesUnfinished++;
+    }
+    replay.movePending = true;
+    replay.moveStartTick = replay.now;
+}
+
+/*
+ * Mirrors timer_group0_isr() of main.c
+ */
+static void replay_isr(void)
+{
+    // Auto reload
+    replay.reloadTick = replay.now;
+    replay.result->isrCalls++;
+
+    int startPressed = btn_start_pressed;
+    int endPressed = btn_end_pressed;
+    TICK_RESULT tick = moveTimerTick(&replay.stepLevel);
+    if (replay.nextAutoTick == REPLAY_NEVER && (startPressed != btn_start_pressed || endPressed != btn_end_pressed))
+    {
+        // The automatic loop of the firmware spins and notices the released limit switch right away
+        replay.nextAutoTick = replay.now;
+    }
+    if (tick == TICK_BLOCKED)
+    {
+        replay.result->isrBlockedCalls++;
+        replay.lastStepValid = false;
+        return;
+    }
+
+    if (replay.stepLevel)
+    {
+        replay.result->steps++;
+        if (replay.lastStepValid)
+        {
+            double periodUs = (replay.now - replay.lastStepTick) * 1e6 / REPLAY_TIMER_SCALE;
+            double idealUs = 1e6 / mm2steps(feedrate / 60.0);
+            double errorUs = fabs(periodUs - idealUs);
+            replay.stepErrorSumUs += errorUs;
+            replay.stepErrorCount++;
+            if (errorUs > replay.result->stepErrorMaxUs)
+            {
+                replay.result->stepErrorMaxUs = errorUs;
+            }
+        }
+        replay.lastStepTick = replay.now;
+        replay.lastStepValid = true;
+    }
+
+    if (tick == TICK_TARGET_REACHED)
+    {
+        moveTimerPause();
+        replay.pausedCounter = 0;
+
+        if (replay.movePending)
+        {
+            replay.movePending = false;
+            replay.result->movesFinished++;
+            if (replay.moveCount < REPLAY_MAX_MOVES)
+            {
+                replay.moveLatencies[replay.moveCount++] = (double)(replay.now - replay.moveStartTick) / REPLAY_TIMER_SCALE;
+            }
+        }
+    }
+}
+
+/*
+ * Mirrors the automatic loop of app_main()
+ */
+static void replay_automatic(void)
+{
+    if (!automatic || replay.now < replay.nextAutoTick)
+    {
+        return;
+    }
+    for (int i = 0; i < REPLAY_MAX_AUTOMATIC_TRIES; i++)
+    {
+        if (automaticMoveStart())
+        {
+            replay_move_started();
+            replay.nextAutoTick = replay.now + (uint64_t)(automaticMoveIntervalSec * REPLAY_TIMER_SCALE);
+            return;
+        }
+        setDirection(!direction);
+    }
+    // Both limit switches block, the firmware spins until an event or the ISR releases one of them
+    replay.nextAutoTick = REPLAY_NEVER;
+}
+
+/*
+ * Runs the timer interrupts and the automatic loop until the given virtual time
+ */
+static void replay_run_until(uint64_t until)
+{
+    while (1)
+    {
+        uint64_t alarm = replay_next_alarm();
+        uint64_t wake = automatic ? replay.nextAutoTick : REPLAY_NEVER;
+        // Events at the same instant are handled before the automatic loop wakes up
+        if (alarm > until && wake >= until)
+        {
+            break;
+        }
+
+        if (alarm <= wake)
+        {
+            if (replay.result->isrCalls && alarm == replay.now && replay.reloadTick == replay.now)
+            {
+                // A second alarm at the same tick, virtual time would not advance anymore
+                replay_fail("Move timer does not advance at %g s", (double)replay.now / REPLAY_TIMER_SCALE);
+                moveTimerPause();
+                continue;
+            }
+            replay.now = alarm;
+            replay_isr();
+        }
+        else
+        {
+            replay.now = wake > replay.now ? wake : replay.now;
+            replay_automatic();
+        }
+    }
+    replay.now = until;
+}
+
+static void replay_fail(const char *format, ...)
+{
+    replay.result->failedExpectations++;
+    if (!replay.result->error[0])
+    {
+        va_list args;
+        va_start(args, format);
+        vsnprintf(replay.result->error, sizeof(replay.result->error), format, args);
+        va_end(args);
+    }
+}
+
+static void replay_button(const char *button, int level)
+{
+    if (!strcmp(button, "start"))
+    {
+        if (level && !replay.startLevel)
+        {
+            replay.startLevel = 1;
+            startButtonHit();
+        }
+        replay.startLevel = level;
+    }
+    else if (!strcmp(button, "end"))
+    {
+        if (level && !replay.endLevel)
+        {
+            replay.endLevel = 1;
+            endButtonHit();
+        }
+        replay.endLevel = level;
+    }
+    else
+    {
+        replay_fail("Unknown button '%s'", button);
+    }
+}
+
+static int replay_compare_double(const void *a, const void *b)
+{
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static double replay_percentile(const double *sorted, int count, double percentile)
+{
+    if (!count)
+    {
+        return 0.0;
+    }
+    int index = (int)ceil(percentile / 100.0 * count) - 1;
+    return sorted[index < 0 ? 0 : index];
+}
+
+/*
+ * Resets the firmware state to its defaults and boots like app_main()
+ */
+static void replay_boot(ReplayResult *result)
+{
+    memset(&replay, 0, sizeof(replay));
+    memset(result, 0, sizeof(*result));
+    replay.result = result;
+
+    feedrate = 550.0;
+    targetPosition = 0;
+    currentPosition = 0;
+    direction = FORWARD;
+    automatic = true;
+    automaticMoveDistanceMM = 100;
+    automaticMoveIntervalSec = 30 * 60;
+    btn_start_pressed = 0;
+    btn_end_pressed = 0;
+
+    moveTimerSetInterval(feedrate2delay(feedrate));
+    goHome();
+}
+
+/**
+  * @brief Replays a trace against the firmware logic in virtual time
+  * @param[in] trace: One event per line: '<time s> <event> [argument]'
+  *                   cmd <command>          Command received over UDP
+  *                   expect <answer>        Answer of the previous command
+  *                   press|release <button> Limit switch 'start' or 'end' changes its level
+  *                   end <steps>            End of the trace with the expected final position
+  * @param[out] result: Measurements of the replay
+  */
+void replay_trace(const char *trace, ReplayResult *result)
+{
+    char answer[128] = "";
+    bool ended = false;
+
+    replay_boot(result);
+
+    while (*trace && !ended)
+    {
+        const char *lineEnd = strchr(trace, '\n');
+        size_t length = lineEnd ? (size_t)(lineEnd - trace) : strlen(trace);
+        char line[160];
+        snprintf(line, sizeof(line), "%.*s", (int)length, trace);
+        trace += length + (lineEnd ? 1 : 0);
+        if (length >= sizeof(line))
+        {
+            replay_fail("Line too long '%.40s...'", line);
+            continue;
+        }
+
+        const char *text = line + strspn(line, " \t\r");
+        if (!*text || *text == '#')
+        {
+            continue;
+        }
+
+        double timeSec;
+        char event[16];
+        int argument = 0;
+        if (sscanf(line, "%lf %15s %n", &timeSec, event, &argument) < 2)
+        {
+            replay_fail("Cannot parse '%s'", line);
+            continue;
+        }
+        const char *arg = line + argument;
+
+        double timeTicks = timeSec * REPLAY_TIMER_SCALE;
+        if (!(timeTicks >= 0.0 && timeTicks < (double)INT64_MAX) || (uint64_t)llround(timeTicks) < replay.now)
+        {
+            replay_fail("Time of '%s' is negative or before the previous event", line);
+            continue;
+        }
+
+        replay_run_until((uint64_t)llround(timeTicks));
+        if (automatic && replay.nextAutoTick == REPLAY_NEVER)
+        {
+            // An event may release the automatic loop spinning between two pressed limit switches
+            replay.nextAutoTick = replay.now;
+        }
+
+        if (!strcmp(event, "cmd"))
+        {
+            uint64_t oldTarget = targetPosition;
+
+            snprintf(answer, sizeof(answer), "%s", arg);
+            handleCommand(answer);
+
+            if (replay.timerRunning && targetPosition != (uint64_t)currentPosition && (!replay.movePending || oldTarget != targetPosition))
+            {
+                replay_move_started();
+            }
+        }
+        else if (!strcmp(event, "expect"))
+        {
+            if (strcmp(answer, arg))
+            {
+                replay_fail("Expected '%s', got '%s'", arg, answer);
+            }
+        }
+        else if (!strcmp(event, "press"))
+        {
+            replay_button(arg, 1);
+        }
+        else if (!strcmp(event, "release"))
+        {
+            replay_button(arg, 0);
+        }
+        else if (!strcmp(event, "end"))
+        {
+            char *end;
+            result->expectedPosition = strtoll(arg, &end, 10);
+            if (end == arg || *(end + strspn(end, " \t\r")))
+            {
+                replay_fail("Invalid final position in '%s'", line);
+            }
+            ended = true;
+        }
+        else
+        {
+            replay_fail("Unknown event '%s'", event);
+        }
+    }
+
+    if (!ended)
+    {
+        replay_fail("Trace has no 'end' event");
+    }
+    if (result->movesFinished > REPLAY_MAX_MOVES)
+    {
+        replay_fail("%d moves finished, only %d latencies can be measured", result->movesFinished, REPLAY_MAX_MOVES);
+    }
+
+    double durationSec = (double)replay.now / REPLAY_TIMER_SCALE;
+    qsort(replay.moveLatencies, replay.moveCount, sizeof(double), replay_compare_double);
+
+    result->stepErrorMeanUs = replay.stepErrorCount ? replay.stepErrorSumUs / replay.stepErrorCount : 0.0;
+    result->isrLoadPercent = durationSec > 0 ? result->isrCalls * REPLAY_ISR_COST_US / (durationSec * 1e6) * 100.0 : 0.0;
+    result->latencyP50Sec = replay_percentile(replay.moveLatencies, replay.moveCount, 50);
+    result->latencyP95Sec = replay_percentile(replay.moveLatencies, replay.moveCount, 95);
+    result->latencyMaxSec = replay_percentile(replay.moveLatencies, replay.moveCount, 100);
+    result->movesUnfinished += replay.movePending ? 1 : 0;
+    result->finalPosition = currentPosition;
+}
+
+#endif /* REPLAY_H */
@@ -0,0 +1,126 @@
+#include <stdio.h>
+#include <unity.h>
+
+#include "replay.h"
+#include "traces.h"
+#include "baselines.h"
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+/*
+ * Prints the measurements and a line in the format of baselines.h
+ */
+static void report(const char *name, const ReplayResult *r)
+{
+    printf("%s: step error max %.3f us mean %.3f us, %llu steps, %llu ISR calls (%llu blocked, %.3f %% load), "
+           "latency p50 %.3f s p95 %.3f s max %.3f s, %d moves (%d unfinished), position %lld\n",
+           name, r->stepErrorMaxUs, r->stepErrorMeanUs, (unsigned long long)r->steps,
+           (unsigned long long)r->isrCalls, (unsigned long long)r->isrBlockedCalls, r->isrLoadPercent,
+           r->latencyP50Sec, r->latencyP95Sec, r->latencyMaxSec, r->movesFinished, r->movesUnfinished,
+           (long long)r->finalPosition);
+    printf("    {\"%s\", %.3f, %.3f, %llu, %llu, %.3f, %.3f, %.3f, %d, %d},\n",
+           name, r->stepErrorMaxUs, r->stepErrorMeanUs, (unsigned long long)r->isrCalls,
+           (unsigned long long)r->isrBlockedCalls, r->latencyP50Sec, r->latencyP95Sec, r->latencyMaxSec,
+           r->movesFinished, r->movesUnfinished);
+}
+
+/*
+ * Fails if the measurement got worse than the baseline by more than the slack.
+ * The replay is deterministic, counts get no slack at all.
+ */
+static void check_regression(const char *trace, const char *metric, double measured, double baseline, double slack)
+{
+    char message[128];
+    snprintf(message, sizeof(message), "%s: %s regressed from %.3f to %.3f", trace, metric, baseline, measured);
+    TEST_ASSERT_TRUE_MESSAGE(measured <= baseline + slack, message);
+}
+
+static const Baseline *find_baseline(const char *name)
+{
+    for (size_t i = 0; i < sizeof(baselines) / sizeof(baselines[0]); i++)
+    {
+        if (!strcmp(baselines[i].name, name))
+        {
+            return &baselines[i];
+        }
+    }
+    return NULL;
+}
+
+static void replay_and_check(const Trace *trace)
+{
+    ReplayResult r;
+    replay_trace(trace->trace, &r);
+    report(trace->name, &r);
+
+    TEST_ASSERT_EQUAL_INT_MESSAGE(0, r.failedExpectations, r.error);
+    TEST_ASSERT_EQUAL_INT64_MESSAGE(r.expectedPosition, r.finalPosition, "Final position");
+
+    const Baseline *b = find_baseline(trace->name);
+    TEST_ASSERT_NOT_NULL_MESSAGE(b, "No baseline for this trace");
+
+    check_regression(trace->name, "max step error [us]", r.stepErrorMaxUs, b->stepErrorMaxUs, REGRESSION_SLACK);
+    check_regression(trace->name, "mean step error [us]", r.stepErrorMeanUs, b->stepErrorMeanUs, REGRESSION_SLACK);
+    check_regression(trace->name, "ISR calls", r.isrCalls, b->isrCalls, 0);
+    check_regression(trace->name, "blocked ISR calls", r.isrBlockedCalls, b->isrBlockedCalls, 0);
+    check_regression(trace->name, "p50 latency [s]", r.latencyP50Sec, b->latencyP50Sec, REGRESSION_SLACK);
+    check_regression(trace->name, "p95 latency [s]", r.latencyP95Sec, b->latencyP95Sec, REGRESSION_SLACK);
+    check_regression(trace->name, "max latency [s]", r.latencyMaxSec, b->latencyMaxSec, REGRESSION_SLACK);
+    check_regression(trace->name, "unfinished moves", r.movesUnfinished, b->movesUnfinished, 0);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(b->movesFinished, r.movesFinished, "Finished moves");
+}
+
+static const Trace *find_trace(const char *name)
+{
+    for (size_t i = 0; i < sizeof(traces) / sizeof(traces[0]); i++)
+    {
+        if (!strcmp(traces[i].name, name))
+        {
+            return &traces[i];
+        }
+    }
+    return NULL;
+}
+
+static void replay_named(const char *name)
+{
+    const Trace *trace = find_trace(name);
+    TEST_ASSERT_NOT_NULL_MESSAGE(trace, name);
+    replay_and_check(trace);
+}
+
+void test_manual_moves(void)
+{
+    replay_named("manual_moves");
+}
+
+void test_homing(void)
+{
+    replay_named("homing");
+}
+
+void test_end_switch(void)
+{
+    replay_named("end_switch");
+}
+
+void test_automatic(void)
+{
+    replay_named("automatic");
+}
+
+int main(void)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_manual_moves);
+    RUN_TEST(test_homing);
+    RUN_TEST(test_end_switch);
+    RUN_TEST(test_automatic);
+    return UNITY_END();
+}
@@ -0,0 +1,93 @@
+#ifndef TRACES_H
+#define TRACES_H
+
+/*
+ * Hand-written scenarios of UDP commands and limit switch events, replayed by replay_trace().
+ * Format: '<time s> <event> [argument]', see replay.h
+ */
+
+typedef struct
+{
+    const char *name;
+    const char *trace;
+} Trace;
+
+static const Trace traces[] = {
+    {"manual_moves",
+     "# Manual positioning with queries, a feedrate change and pause/resume\n"
+     "0 cmd Mode=Manual\n"
+     "0 expect Setting Mode to Manual\n"
+     "0 press start\n"
+     "0.2 release start\n"
+     "0.5 cmd Pos=10\n"
+     "0.5 expect Target Position  = 10.000000 mm (250 steps)\n"
+     "3 cmd ?Pos\n"
+     "3 expect Current Position = 10.000000 mm (250 steps)\n"
+     "3 cmd Feedrate=1100\n"
+     "3 expect New Feedrate = 1100.000000 mm/min (delay = 0.001091 s)\n"
+     "3 cmd Pos=50\n"
+     "5 cmd Pause\n"
+     "6 cmd Resume\n"
+     "12 cmd ?Pos\n"
+     "12 expect Current Position = 50.000000 mm (1250 steps)\n"
+     "12 cmd Feedrate=300\n"
+     "12 cmd Pos=20\n"
+     "14 cmd Pos=-5\n"
+     "14 expect Negative Positions not allowed\n"
+     "14 cmd Pos=25\n"
+     "30 cmd ?Pos\n"
+     "30 expect Current Position = 25.000000 mm (625 steps)\n"
+     "30 end 625\n"},
+
+    {"homing",
+     "# Homing in manual mode, the start button stops the carriage\n"
+     "0 cmd Mode=Manual\n"
+     "0 cmd Home\n"
+     "0 expect Going Home\n"
+     "10 press start\n"
+     "10.2 release start\n"
+     "10.5 cmd ?Home\n"
+     "10.5 expect Not Home: 100\n"
+     "11 cmd Pos=5\n"
+     "11 expect Target Position  = 5.000000 mm (125 steps)\n"
+     "15 cmd Home\n"
+     "15 expect Going Home\n"
+     "16 press start\n"
+     "16 cmd Home\n"
+     "16 expect Already Home\n"
+     "17 release start\n"
+     "20 end 0\n"},
+
+    {"end_switch",
+     "# A long move is stopped by the end button and moves back\n"
+     "0 cmd Mode=Manual\n"
+     "0 press start\n"
+     "0.2 release start\n"
+     "0.5 cmd Pos=600\n"
+     "30 press end\n"
+     "30.5 cmd ?End\n"
+     "30.5 expect Is End: 100\n"
+     "31 cmd Pos=650\n"
+     "31 expect Can't move forward, because end button is pressed\n"
+     "31.5 release end\n"
+     "32 cmd Pos=100\n"
+     "70 end 2500\n"},
+
+    {"automatic",
+     "# Automatic mode moves between the limit switches\n"
+     "0 cmd AutomaticMoveDistance=20\n"
+     "0 cmd AutomaticMoveInterval=5\n"
+     "0 press start\n"
+     "0.2 release start\n"
+     "12 press end\n"
+     "12.2 release end\n"
+     "19 cmd ?Mode\n"
+     "19 expect Current Mode = Automatic\n"
+     "19 cmd Mode=Manual\n"
+     "24 cmd Mode=Automatic\n"
+     "31.5 press start\n"
+     "32 release start\n"
+     "38 end 500\n"},
+};
+
+#endif /* TRACES_H */